@@ -0,0 +1,137 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include "mapped_file.h"
+#include "histogram_snapshot.h"
+
+void printHistogram(std::vector<uint32_t> &histogram) {
+    std::cout << "[";
+    for (const auto &element : histogram) {
+        std::cout << std::setw(8) << element;
+    }
+    std::cout << "]" << std::endl;
+}
+
+void writeSnapshot(const std::string &path, const std::vector<uint32_t> &histogram) {
+    auto snapshot = encodeSnapshot(histogram.data(), histogram.size());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(snapshot.data()), snapshot.size());
+    if (!file) throw std::runtime_error("Could not write " + path);
+}
+
+std::vector<uint32_t> readSnapshot(const std::string &path) {
+    MappedFile file(path.c_str());
+    return decodeSnapshot(file.data(), file.size());
+}
+
+std::vector<uint32_t> __attribute__ ((noinline)) aggregateSequential(const std::vector<std::string> &paths) {
+    std::vector<uint32_t> result;
+
+    for (const auto &path : paths) {
+        auto histogram = readSnapshot(path);
+        if (result.empty()) result.resize(histogram.size());
+        if (histogram.size() != result.size()) throw std::runtime_error("Histograms with different ranges cannot be merged");
+
+        for (size_t bin = 0; bin < histogram.size(); bin++) {
+            result[bin] += histogram[bin];
+        }
+    }
+
+    return result;
+}
+
+// Adds every snapshot into the result right after it is mapped, so only one histogram of the full range is kept in memory
+std::vector<uint32_t> __attribute__ ((noinline)) aggregateVector(const std::vector<std::string> &paths) {
+    std::vector<uint32_t> result;
+
+    for (const auto &path : paths) {
+        MappedFile file(path.c_str());
+        mergeSnapshot(file.data(), file.size(), result);
+    }
+
+    return result;
+}
+
+// Writes partial histograms of normally distributed values as snapshots to disk, then aggregates them again
+template<uint32_t histogram_range>
+void testRange(size_t partials, double deviation) {
+    const size_t values = 1'000'000;
+    std::cout << "Aggregating " << partials << " histograms between 0 and " << histogram_range << " (exclusive):" << std::endl;
+
+    std::random_device seed;
+    std::default_random_engine rnd(seed());
+    std::normal_distribution<double> dist(histogram_range / 2.0, deviation);
+
+    auto directory = std::filesystem::temp_directory_path();
+    std::vector<std::string> paths;
+    size_t snapshot_size = 0;
+
+    for (size_t partial = 0; partial < partials; partial++) {
+        std::vector<uint32_t> histogram(histogram_range);
+        for (size_t i = 0; i < values; i++) {
+            histogram[std::clamp<long>(std::lround(dist(rnd)), 0, histogram_range - 1)]++;
+        }
+
+        paths.push_back(directory / ("histogram_" + std::to_string(histogram_range) + "_" + std::to_string(partial) + ".hist"));
+        writeSnapshot(paths.back(), histogram);
+        snapshot_size += std::filesystem::file_size(paths.back());
+    }
+
+    std::cout << "The snapshots take " << snapshot_size << " bytes, printed as text they would take "
+              << partials * (histogram_range * 8 + 2) << " bytes" << std::endl;
+
+    std::cout << "Sequential:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto sequential = aggregateSequential(paths);
+    auto after = std::chrono::high_resolution_clock::now();
+    if (histogram_range <= 256) printHistogram(sequential);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (merge):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    auto result = aggregateVector(paths);
+    after = std::chrono::high_resolution_clock::now();
+    if (histogram_range <= 256) printHistogram(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Both aggregates are " << (result == sequential ? "equal" : "DIFFERENT") << std::endl;
+
+    for (const auto &path : paths) {
+        std::filesystem::remove(path);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc == 2 || (argc > 1 && std::string(argv[1]) == "--help")) {
+        std::cerr << "Usage: " << argv[0] << std::endl;
+        std::cerr << "       " << argv[0] << " <merged snapshot> <snapshot>..." << std::endl;
+        return 1;
+    }
+
+    try {
+        if (argc > 2) {
+            std::vector<std::string> paths(argv + 2, argv + argc);
+            writeSnapshot(argv[1], aggregateVector(paths));
+            return 0;
+        }
+
+        testRange<256>(16, 16);
+        std::cout << "\n----------------------------------------\n";
+        testRange<65536>(16, 256);
+        std::cout << "\n----------------------------------------\n";
+        testRange<1 << 20>(16, 64);
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+const size_t READ_BLOCK_SIZE = 4 * 1024 * 1024;
+const size_t BLOCK_ALIGNMENT = 4096;
+const size_t BUFFER_COUNT = 4;
+
+// Queue between exactly one producer and one consumer thread. The slots are handed over lock-free.
+// A consumer that finds it empty can block in popWait() until the next push, so every push briefly takes the mutex
+// to wake it up. That is cheap since every value stands for a whole block of the file.
+template<typename type, size_t capacity>
+class SpscRing {
+    static_assert((capacity & (capacity - 1)) == 0, "The capacity has to be a power of two");
+
+public:
+    bool push(const type &value) {
+        size_t tail = write_position.load(std::memory_order_relaxed);
+        if (tail - read_position.load(std::memory_order_acquire) == capacity) return false;
+
+        slots[tail & (capacity - 1)] = value;
+        write_position.store(tail + 1, std::memory_order_release);
+
+        // Taking the mutex orders this push against a consumer that is checking for values before it goes to sleep
+        { std::lock_guard<std::mutex> lock(mutex); }
+        condition.notify_one();
+        return true;
+    }
+
+    bool pop(type &value) {
+        size_t head = read_position.load(std::memory_order_relaxed);
+        if (head == write_position.load(std::memory_order_acquire)) return false;
+
+        value = slots[head & (capacity - 1)];
+        read_position.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Blocks until a value arrives. Returns false if the ring was stopped instead.
+    bool popWait(type &value) {
+        if (pop(value)) return true;
+
+        bool popped = false;
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&] { return (popped = pop(value)) || stopped; });
+        return popped;
+    }
+
+    // Wakes up a blocked consumer for good
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+        condition.notify_all();
+    }
+
+private:
+    std::array<type, capacity> slots = {};
+    alignas(64) std::atomic<size_t> write_position = 0;
+    alignas(64) std::atomic<size_t> read_position = 0;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopped = false;
+};
+
+// Minimal io_uring for reads without liburing. setup() fails if the kernel does not provide io_uring or forbids it.
+class IoUring {
+public:
+    bool setup(unsigned entries) {
+        io_uring_params params = {};
+        ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+        if (ring_fd < 0) return false;
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = std::max(sq_size, cq_size);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+        sq_ring = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+        cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq_ring
+                : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        void *sqe_mapping = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+        if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqe_mapping == MAP_FAILED) {
+            // The rings are unmapped by the destructor, the submission entries are not tracked yet
+            if (sqe_mapping != MAP_FAILED) munmap(sqe_mapping, sqes_size);
+            return false;
+        }
+
+        auto sq_bytes = static_cast<uint8_t *>(sq_ring);
+        sq_tail = reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.tail);
+        sq_mask = *reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq_bytes + params.sq_off.array);
+        sqes = static_cast<io_uring_sqe *>(sqe_mapping);
+
+        auto cq_bytes = static_cast<uint8_t *>(cq_ring);
+        cq_head = reinterpret_cast<unsigned *>(cq_bytes + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq_bytes + params.cq_off.tail);
+        cq_mask = *reinterpret_cast<unsigned *>(cq_bytes + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq_bytes + params.cq_off.cqes);
+
+        return true;
+    }
+
+    ~IoUring() {
+        if (sqes != nullptr) munmap(sqes, sqes_size);
+        if (cq_ring != nullptr && cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_size);
+        if (sq_ring != nullptr && sq_ring != MAP_FAILED) munmap(sq_ring, sq_size);
+        if (ring_fd >= 0) close(ring_fd);
+    }
+
+    // Returns false if the kernel did not take the read, which then is not in flight
+    bool submitRead(int fd, iovec *vector, off_t offset, uint64_t user_data) {
+        unsigned tail = *sq_tail;
+        unsigned index = tail & sq_mask;
+
+        io_uring_sqe &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = IORING_OP_READV;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(vector);
+        sqe.len = 1;
+        sqe.off = offset;
+        sqe.user_data = user_data;
+
+        sq_array[index] = index;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+        while (true) {
+            long submitted = syscall(__NR_io_uring_enter, ring_fd, 1, 0, 0, nullptr, 0);
+            if (submitted == 1) return true;
+            if (submitted < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+
+            // The kernel has not consumed the entry, take it back out of the ring
+            __atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+            return false;
+        }
+    }
+
+    // Returns false if waiting failed, a completion may still arrive later
+    bool waitCompletion(uint64_t &user_data, int &result) {
+        unsigned head = *cq_head;
+        while (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE)) {
+            if (syscall(__NR_io_uring_enter, ring_fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0
+                && errno != EINTR && errno != EAGAIN) return false;
+        }
+
+        const io_uring_cqe &cqe = cqes[head & cq_mask];
+        user_data = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+private:
+    int ring_fd = -1;
+    size_t sq_size = 0, cq_size = 0, sqes_size = 0;
+    void *sq_ring = nullptr, *cq_ring = nullptr;
+    unsigned *sq_tail = nullptr, *sq_array = nullptr, sq_mask = 0;
+    unsigned *cq_head = nullptr, *cq_tail = nullptr, cq_mask = 0;
+    io_uring_sqe *sqes = nullptr;
+    io_uring_cqe *cqes = nullptr;
+};
+
+struct Block {
+    const uint8_t *data;
+    size_t size;
+    size_t index;
+};
+
+// Reads a file in blocks of READ_BLOCK_SIZE bytes on a separate thread while the calling thread computes on the previous blocks.
+// BUFFER_COUNT aligned buffers circulate between both threads through two SPSC rings: filled ones go to the consumer,
+// recycled ones go back to the reader. The reader keeps a read in flight for every free buffer with io_uring,
+// or falls back to blocking pread calls if io_uring is not available.
+// Blocks are handed out in completion order, which is not necessarily the order in the file.
+class BlockPipeline {
+public:
+    explicit BlockPipeline(const char *path) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error(std::string("Could not open ") + path);
+
+        struct stat info = {};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error(std::string("Could not stat ") + path);
+        }
+        file_size = info.st_size;
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        for (size_t i = 0; i < BUFFER_COUNT; i++) {
+            buffers[i] = static_cast<uint8_t *>(std::aligned_alloc(BLOCK_ALIGNMENT, READ_BLOCK_SIZE));
+            if (buffers[i] == nullptr) {
+                for (auto buffer : buffers) std::free(buffer);
+                close(fd);
+                throw std::runtime_error("Could not allocate the read buffers");
+            }
+            free_buffers.push(i);
+        }
+
+        io_uring_available = ring.setup(BUFFER_COUNT);
+        reader = std::thread(io_uring_available ? &BlockPipeline::readIoUring : &BlockPipeline::readPread, this);
+    }
+
+    BlockPipeline(const BlockPipeline &) = delete;
+    BlockPipeline &operator=(const BlockPipeline &) = delete;
+
+    ~BlockPipeline() {
+        stopping.store(true, std::memory_order_relaxed);
+        free_buffers.stop();
+        reader.join();
+
+        for (auto buffer : buffers) std::free(buffer);
+        close(fd);
+    }
+
+    // Waits for the next filled block. Returns false once the whole file has been handed out.
+    bool next(Block &block) {
+        size_t index;
+        filled_buffers.popWait(index);
+
+        if (index == END_OF_FILE) {
+            if (!error.empty()) throw std::runtime_error(error);
+            return false;
+        }
+
+        block = {buffers[index], block_sizes[index], index};
+        return true;
+    }
+
+    // Hands the buffer of a block back to the reader
+    void recycle(const Block &block) {
+        free_buffers.push(block.index);
+    }
+
+    bool usesIoUring() const {
+        return io_uring_available;
+    }
+
+    size_t size() const {
+        return file_size;
+    }
+
+private:
+    static constexpr size_t END_OF_FILE = SIZE_MAX;
+
+    // Room for every buffer plus the end marker
+    SpscRing<size_t, 8> free_buffers;
+    SpscRing<size_t, 8> filled_buffers;
+
+    std::array<uint8_t *, BUFFER_COUNT> buffers = {};
+    std::array<size_t, BUFFER_COUNT> block_sizes = {};
+    std::array<iovec, BUFFER_COUNT> vectors = {};
+
+    int fd = -1;
+    size_t file_size = 0;
+    IoUring ring;
+    bool io_uring_available = false;
+    std::string error;
+    std::atomic<bool> stopping = false;
+    std::thread reader;
+
+    // Reads until the buffer is full or the file ends, pread may return less than requested
+    bool readFully(size_t index, size_t filled, size_t length, off_t offset) {
+        while (filled < length) {
+            ssize_t result = pread(fd, buffers[index] + filled, length - filled, offset + filled);
+            if (result < 0 && errno == EINTR) continue;
+            if (result <= 0) return false;
+            filled += result;
+        }
+        return true;
+    }
+
+    void finish(const std::string &message) {
+        error = message;
+        filled_buffers.push(END_OF_FILE);
+    }
+
+    void readPread() {
+        for (size_t offset = 0; offset < file_size; offset += READ_BLOCK_SIZE) {
+            size_t index;
+            if (!free_buffers.popWait(index)) return;
+
+            block_sizes[index] = std::min(READ_BLOCK_SIZE, file_size - offset);
+            if (!readFully(index, 0, block_sizes[index], offset)) return finish("Could not read the file");
+
+            filled_buffers.push(index);
+        }
+
+        finish("");
+    }
+
+    void readIoUring() {
+        std::array<size_t, BUFFER_COUNT> block_offsets = {};
+        size_t offset = 0;
+        size_t in_flight = 0;
+        std::string message;
+
+        while (offset < file_size || in_flight != 0) {
+            // Start a read for every free buffer. Only block for a recycled buffer if there is nothing else to wait for.
+            size_t index;
+            while (message.empty() && !stopping.load(std::memory_order_relaxed) && offset < file_size
+                   && (in_flight == 0 ? free_buffers.popWait(index) : free_buffers.pop(index))) {
+                block_offsets[index] = offset;
+                block_sizes[index] = std::min(READ_BLOCK_SIZE, file_size - offset);
+                vectors[index] = {buffers[index], block_sizes[index]};
+
+                if (!ring.submitRead(fd, &vectors[index], offset, index)) {
+                    message = "Could not submit a read";
+                    break;
+                }
+                offset += block_sizes[index];
+                in_flight++;
+            }
+
+            // Either the ring was stopped, a read failed or the whole file has been handed out
+            if (in_flight == 0) break;
+
+            uint64_t user_data;
+            int result;
+            // The kernel may still write into the buffers, so even a failed wait keeps draining until nothing is in flight
+            if (!ring.waitCompletion(user_data, result)) {
+                message = "Could not wait for a read";
+                continue;
+            }
+            in_flight--;
+            index = user_data;
+
+            if (result < 0 || !readFully(index, result, block_sizes[index], block_offsets[index])) {
+                message = "Could not read the file";
+                continue;
+            }
+            // Reads that are still in flight have to be drained before the buffers can be freed
+            if (!message.empty() || stopping.load(std::memory_order_relaxed)) continue;
+
+            filled_buffers.push(index);
+        }
+
+        finish(message);
+    }
+};
@@ -130,6 +130,77 @@ std::array<ElementType, range> __attribute__ ((noinline)) convolutionalHistogram
     return histogram;
 }
 
+#ifdef __AVX512BW__
+// Same filter on 8-bit pixels. The sum of nine pixels fits into 16 bits, so 32 pixels are filtered per vector
+// and only the results are widened to 32-bit indices for the gather and scatter.
+template<ElementType range>
+std::array<ElementType, range> __attribute__ ((noinline)) convolutionalHistogramShiftedVectorEpi16(std::vector<uint8_t> &data, size_t rows, size_t cols) {
+    std::array<ElementType, range> histogram = {};
+
+    if (data.size() != rows * cols) return histogram;
+
+    const size_t PIXEL_COUNT = VECTOR_SIZE / sizeof(int16_t);
+    auto inc_const = _mm512_set1_epi32(1);
+    // ceil(2^16 / 9), exact for every sum of nine 8-bit values
+    auto div_multiplier = _mm512_set1_epi16(7282);
+
+    auto load = [&](size_t row, size_t col) {
+        return _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(&data[row * cols + col])));
+    };
+
+    for (size_t current_row = 1; current_row < rows - 1; current_row++) {
+        size_t current_col = 1;
+        for (; current_col + PIXEL_COUNT <= cols - 1; current_col += PIXEL_COUNT) {
+            auto pixels_vec = load(current_row, current_col);
+
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row + 1, current_col + 1));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row + 1, current_col));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row + 1, current_col - 1));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row, current_col + 1));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row, current_col - 1));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row - 1, current_col + 1));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row - 1, current_col));
+            pixels_vec = _mm512_adds_epu16(pixels_vec, load(current_row - 1, current_col - 1));
+            pixels_vec = _mm512_mulhi_epu16(pixels_vec, div_multiplier);
+
+            for (int half = 0; half < 2; half++) {
+                auto data_vec = _mm512_cvtepu16_epi32(half == 0 ? _mm512_castsi512_si256(pixels_vec) : _mm512_extracti64x4_epi64(pixels_vec, 1));
+
+                auto conflicts = _mm512_conflict_epi32(data_vec);
+                auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+                histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+                while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+                    auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+                    histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+                    conflicts = _mm512_srli_epi32(conflicts, 1);
+                }
+
+                _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+            }
+        }
+
+        for (; current_col < cols - 1; current_col++) {
+            ElementType value = data[current_row * cols + current_col];
+            value += data[(current_row + 1) * cols + (current_col + 1)];
+            value += data[(current_row + 1) * cols + current_col];
+            value += data[(current_row + 1) * cols + (current_col - 1)];
+            value += data[current_row * cols + (current_col + 1)];
+            value += data[current_row * cols + (current_col - 1)];
+            value += data[(current_row - 1) * cols + (current_col + 1)];
+            value += data[(current_row - 1) * cols + current_col];
+            value += data[(current_row - 1) * cols + (current_col - 1)];
+
+            value /= 9;
+
+            histogram[value]++;
+        }
+    }
+
+    return histogram;
+}
+#endif
+
 template<ElementType range>
 std::array<ElementType, range> __attribute__ ((noinline)) convolutionalHistogramSequential(std::vector<ElementType> &data, size_t rows, size_t cols) {
     std::array<ElementType, range> histogram = {};
@@ -164,7 +235,7 @@ void testRange() {
 
     std::random_device seed;
     std::default_random_engine rnd(seed());
-    std::uniform_int_distribution<ElementType> dist(0, histogram_range);
+    std::uniform_int_distribution<ElementType> dist(0, histogram_range - 1);
     std::vector<ElementType> data(rows * cols);
 
     for (ElementType &i: data)
@@ -184,6 +255,17 @@ void testRange() {
     printArray(result);
     std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
 
+#ifdef __AVX512BW__
+    std::vector<uint8_t> pixels(data.begin(), data.end());
+
+    std::cout << "Vector Instructions (8-bit pixels, 16-bit lanes):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = convolutionalHistogramShiftedVectorEpi16<histogram_range>(pixels, rows, cols);
+    after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+#endif
+
     std::cout << "Sequential (again):" << std::endl;
     before = std::chrono::high_resolution_clock::now();
     result = convolutionalHistogramSequential<histogram_range>(data, rows, cols);
@@ -0,0 +1,218 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <immintrin.h>
+#include <algorithm>
+
+const size_t VECTOR_SIZE = 512 / 8;
+using ElementType = uint32_t;
+const size_t ELEMENT_COUNT = VECTOR_SIZE / sizeof(ElementType);
+
+struct Offset {
+    int row;
+    int col;
+};
+
+template<ElementType range>
+void printMatrix(std::array<ElementType, range * range> &matrix) {
+    for (size_t row = 0; row < range; row++) {
+        std::cout << (row == 0 ? "[[" : " [");
+        for (size_t col = 0; col < range; col++) {
+            std::cout << std::setw(8) << matrix[row * range + col];
+        }
+        std::cout << (row == range - 1 ? "]]" : "]") << std::endl;
+    }
+}
+
+// Joint histogram of two columns. The pair (a, b) is flattened into the bin a * range + b.
+template<ElementType range>
+std::array<ElementType, range * range> __attribute__ ((noinline)) jointHistogramShiftedVector(std::vector<ElementType> &first, std::vector<ElementType> &second) {
+    std::array<ElementType, range * range> histogram = {};
+
+    if (first.size() != second.size()) return histogram;
+
+    auto inc_const = _mm512_set1_epi32(1);
+    auto range_const = _mm512_set1_epi32(range);
+
+    for (size_t i = 0; i + ELEMENT_COUNT <= first.size(); i += ELEMENT_COUNT) {
+        auto first_vec = _mm512_loadu_si512(first.data() + i);
+        auto second_vec = _mm512_loadu_si512(second.data() + i);
+        auto data_vec = _mm512_add_epi32(_mm512_mullo_epi32(first_vec, range_const), second_vec);
+
+        auto conflicts = _mm512_conflict_epi32(data_vec);
+        auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+        histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+        while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+            auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+            histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+            conflicts = _mm512_srli_epi32(conflicts, 1);
+        }
+
+        _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+    }
+
+    for (size_t i = first.size() & ~(ELEMENT_COUNT - 1); i < first.size(); i++) {
+        histogram[first[i] * range + second[i]]++;
+    }
+
+    return histogram;
+}
+
+template<ElementType range>
+std::array<ElementType, range * range> __attribute__ ((noinline)) jointHistogramSequential(std::vector<ElementType> &first, std::vector<ElementType> &second) {
+    std::array<ElementType, range * range> histogram = {};
+
+    if (first.size() != second.size()) return histogram;
+
+    for (size_t i = 0; i < first.size(); i++) {
+        histogram[first[i] * range + second[i]]++;
+    }
+
+    return histogram;
+}
+
+// Gray-level co-occurrence matrix. Every offset is accumulated into the same table while a row is still in cache,
+// so the image is only streamed once no matter how many offsets are requested.
+template<ElementType range>
+std::array<ElementType, range * range> __attribute__ ((noinline)) cooccurrenceHistogramShiftedVector(std::vector<ElementType> &data, size_t rows, size_t cols, std::vector<Offset> &offsets) {
+    std::array<ElementType, range * range> histogram = {};
+
+    if (data.size() != rows * cols) return histogram;
+
+    auto inc_const = _mm512_set1_epi32(1);
+    auto range_const = _mm512_set1_epi32(range);
+
+    for (size_t current_row = 0; current_row < rows; current_row++) {
+        for (const auto &offset : offsets) {
+            long neighbour_row = (long) current_row + offset.row;
+            if (neighbour_row < 0 || neighbour_row >= (long) rows) continue;
+            if (std::abs(offset.col) >= (long) cols) continue;
+
+            size_t col_begin = std::max(0, -offset.col);
+            size_t col_end = cols - std::max(0, offset.col);
+
+            // The column offset is only added to in-bounds column indices, so no pointer before the row is ever formed
+            const ElementType *center_row = data.data() + current_row * cols;
+            const ElementType *neighbour_row_data = data.data() + neighbour_row * cols;
+
+            size_t current_col = col_begin;
+            for (; current_col + ELEMENT_COUNT <= col_end; current_col += ELEMENT_COUNT) {
+                auto center = _mm512_loadu_si512(center_row + current_col);
+                auto neighbour = _mm512_loadu_si512(neighbour_row_data + current_col + offset.col);
+                auto data_vec = _mm512_add_epi32(_mm512_mullo_epi32(center, range_const), neighbour);
+
+                auto conflicts = _mm512_conflict_epi32(data_vec);
+                auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+                histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+                while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+                    auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+                    histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+                    conflicts = _mm512_srli_epi32(conflicts, 1);
+                }
+
+                _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+            }
+
+            for (; current_col < col_end; current_col++) {
+                histogram[center_row[current_col] * range + neighbour_row_data[current_col + offset.col]]++;
+            }
+        }
+    }
+
+    return histogram;
+}
+
+template<ElementType range>
+std::array<ElementType, range * range> __attribute__ ((noinline)) cooccurrenceHistogramSequential(std::vector<ElementType> &data, size_t rows, size_t cols, std::vector<Offset> &offsets) {
+    std::array<ElementType, range * range> histogram = {};
+
+    if (data.size() != rows * cols) return histogram;
+
+    for (const auto &offset : offsets) {
+        for (long current_row = std::max(0, -offset.row); current_row < std::min((long) rows, (long) rows - offset.row); current_row++) {
+            for (long current_col = std::max(0, -offset.col); current_col < std::min((long) cols, (long) cols - offset.col); current_col++) {
+                ElementType center = data[current_row * cols + current_col];
+                ElementType neighbour = data[(current_row + offset.row) * cols + (current_col + offset.col)];
+
+                histogram[center * range + neighbour]++;
+            }
+        }
+    }
+
+    return histogram;
+}
+
+template<ElementType histogram_range>
+void testRange() {
+    const size_t rows = 1000, cols = 1000;
+    std::cout << "Joint histogram between 0 and " << histogram_range << " (exclusive):" << std::endl;
+
+    std::random_device seed;
+    std::default_random_engine rnd(seed());
+    std::uniform_int_distribution<ElementType> dist(0, histogram_range - 1);
+    std::vector<ElementType> first(rows * cols);
+    std::vector<ElementType> second(rows * cols);
+
+    for (ElementType &i : first)
+        i = dist(rnd);
+    for (ElementType &i : second)
+        i = dist(rnd);
+
+    std::cout << "Sequential:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto result = jointHistogramSequential<histogram_range>(first, second);
+    auto after = std::chrono::high_resolution_clock::now();
+    printMatrix<histogram_range>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (shifted vector):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = jointHistogramShiftedVector<histogram_range>(first, second);
+    after = std::chrono::high_resolution_clock::now();
+    printMatrix<histogram_range>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    // 0°, 45°, 90° and 135° at distance 1
+    std::vector<Offset> offsets = {{0, 1}, {-1, 1}, {-1, 0}, {-1, -1}};
+    std::cout << "Co-occurrence matrix between 0 and " << histogram_range << " (exclusive), " << offsets.size() << " offsets:" << std::endl;
+
+    std::cout << "Sequential:" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = cooccurrenceHistogramSequential<histogram_range>(first, rows, cols, offsets);
+    after = std::chrono::high_resolution_clock::now();
+    printMatrix<histogram_range>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (shifted vector):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = cooccurrenceHistogramShiftedVector<histogram_range>(first, rows, cols, offsets);
+    after = std::chrono::high_resolution_clock::now();
+    printMatrix<histogram_range>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Sequential (again):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = cooccurrenceHistogramSequential<histogram_range>(first, rows, cols, offsets);
+    after = std::chrono::high_resolution_clock::now();
+    printMatrix<histogram_range>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+}
+
+int main() {
+    testRange<4>();
+    std::cout << "\n----------------------------------------\n";
+    testRange<8>();
+    std::cout << "\n----------------------------------------\n";
+    testRange<16>();
+
+    return 0;
+}
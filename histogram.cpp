@@ -103,6 +103,61 @@ std::array<ElementType, range> __attribute__ ((noinline)) histogramShiftedVector
     return histogram;
 }
 
+// Processes unroll vectors per iteration so their gathers can overlap.
+// All gathers of a group read the histogram before any of its scatters, so a lane additionally has to count the equal lanes
+// in the earlier vectors of the group. Those are found by comparing against every rotation of the earlier vectors.
+// The scatters are issued in order, so the last lane of every bin writes the complete count.
+template<ElementType range, size_t unroll>
+std::array<ElementType, range> __attribute__ ((noinline)) histogramUnrolledShiftedVector(std::vector<ElementType> &data) {
+    std::array<ElementType, range> histogram = {};
+
+    const size_t GROUP_SIZE = unroll * ELEMENT_COUNT;
+    auto inc_const = _mm512_set1_epi32(1);
+    auto lane_mask = _mm512_set1_epi32(ELEMENT_COUNT - 1);
+    auto lane_index = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+
+    for (size_t i = 0; i + GROUP_SIZE <= data.size(); i += GROUP_SIZE) {
+        __m512i data_vecs[unroll];
+        __m512i histogram_vecs[unroll];
+
+        for (size_t v = 0; v < unroll; v++) {
+            data_vecs[v] = _mm512_loadu_si512(data.data() + i + v * ELEMENT_COUNT);
+            histogram_vecs[v] = _mm512_i32gather_epi32(data_vecs[v], histogram.data(), sizeof(ElementType));
+        }
+
+        for (size_t v = 0; v < unroll; v++) {
+            auto conflicts = _mm512_conflict_epi32(data_vecs[v]);
+            histogram_vecs[v] = _mm512_add_epi32(histogram_vecs[v], inc_const);
+
+            while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+                auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+                histogram_vecs[v] = _mm512_add_epi32(histogram_vecs[v], conflicts_bit1);
+                conflicts = _mm512_srli_epi32(conflicts, 1);
+            }
+
+            auto rotation = lane_index;
+            for (size_t k = 0; k < ELEMENT_COUNT; k++) {
+                for (size_t u = 0; u < v; u++) {
+                    auto rotated = _mm512_permutexvar_epi32(rotation, data_vecs[u]);
+                    auto equal = _mm512_cmpeq_epi32_mask(data_vecs[v], rotated);
+                    histogram_vecs[v] = _mm512_mask_add_epi32(histogram_vecs[v], equal, histogram_vecs[v], inc_const);
+                }
+                rotation = _mm512_and_si512(_mm512_add_epi32(rotation, inc_const), lane_mask);
+            }
+        }
+
+        for (size_t v = 0; v < unroll; v++) {
+            _mm512_i32scatter_epi32(histogram.data(), data_vecs[v], histogram_vecs[v], sizeof(ElementType));
+        }
+    }
+
+    for (size_t i = data.size() / GROUP_SIZE * GROUP_SIZE; i < data.size(); i++) {
+        histogram[data[i]]++;
+    }
+
+    return histogram;
+}
+
 template<ElementType range>
 std::array<ElementType, range> __attribute__ ((noinline)) histogramPOPCNT(std::vector<ElementType> &data) {
     std::array<ElementType, range> histogram = {};
@@ -127,6 +182,100 @@ std::array<ElementType, range> __attribute__ ((noinline)) histogramPOPCNT(std::v
     return histogram;
 }
 
+// For small ranges the whole histogram fits into registers, so no gather or scatter is needed.
+// Every bin keeps one counter per lane that is incremented where the lane equals the bin,
+// the lanes are only summed up once at the end.
+// One ZMM register per bin only pays off while all counters stay in the 32 registers, larger ranges use the byte kernel below.
+template<ElementType range>
+std::array<ElementType, range> __attribute__ ((noinline)) histogramCompareCount(std::vector<ElementType> &data) {
+    static_assert(range <= 16, "The counters of every bin have to fit into registers");
+
+    std::array<ElementType, range> histogram = {};
+    __m512i counters[range];
+
+    auto minus_one = _mm512_set1_epi32(-1);
+    for (auto &counter : counters) {
+        counter = _mm512_setzero_si512();
+    }
+
+    for (size_t i = 0; i + ELEMENT_COUNT <= data.size(); i += ELEMENT_COUNT) {
+        auto data_vec = _mm512_loadu_si512(data.data() + i);
+
+        for (ElementType bin = 0; bin < range; bin++) {
+            auto equal = _mm512_cmpeq_epi32_mask(data_vec, _mm512_set1_epi32(bin));
+            counters[bin] = _mm512_mask_sub_epi32(counters[bin], equal, counters[bin], minus_one);
+        }
+    }
+
+    for (ElementType bin = 0; bin < range; bin++) {
+        histogram[bin] = _mm512_reduce_add_epi32(counters[bin]);
+    }
+
+    for (size_t i = data.size() & ~(ELEMENT_COUNT - 1); i < data.size(); i++) {
+        histogram[data[i]]++;
+    }
+
+    return histogram;
+}
+
+#ifdef __AVX512BW__
+// Narrows four vectors to bytes so that a single compare covers 64 values.
+// Like histogramCompareCount every bin keeps one counter per lane in a register, but a byte wide one.
+// A byte overflows after 255 blocks, so the data is narrowed in chunks of that many blocks into a buffer that stays in L1.
+// The counters of 16 bins at a time run over a chunk and are only summed up into the histogram afterwards.
+template<ElementType range>
+std::array<ElementType, range> __attribute__ ((noinline)) histogramCompareCountBytes(std::vector<ElementType> &data) {
+    static_assert(range <= 256, "The values have to fit into a byte");
+
+    const size_t BLOCK_SIZE = 4 * ELEMENT_COUNT;
+    const size_t CHUNK_BLOCKS = 255;
+    const ElementType BINS_PER_PASS = std::min<ElementType>(16, range);
+
+    std::array<ElementType, range> histogram = {};
+    alignas(VECTOR_SIZE) uint8_t bytes[CHUNK_BLOCKS * BLOCK_SIZE];
+
+    auto zero = _mm512_setzero_si512();
+    auto minus_one = _mm512_set1_epi8(-1);
+    const size_t blocks = data.size() / BLOCK_SIZE;
+
+    for (size_t chunk = 0; chunk < blocks; chunk += CHUNK_BLOCKS) {
+        const size_t chunk_blocks = std::min(CHUNK_BLOCKS, blocks - chunk);
+        const ElementType *chunk_data = data.data() + chunk * BLOCK_SIZE;
+
+        for (size_t i = 0; i < chunk_blocks * BLOCK_SIZE; i += ELEMENT_COUNT) {
+            _mm_store_si128(reinterpret_cast<__m128i *>(bytes + i), _mm512_cvtepi32_epi8(_mm512_loadu_si512(chunk_data + i)));
+        }
+
+        for (ElementType first_bin = 0; first_bin < range; first_bin += BINS_PER_PASS) {
+            __m512i counters[BINS_PER_PASS];
+            for (auto &counter : counters) {
+                counter = zero;
+            }
+
+            for (size_t block = 0; block < chunk_blocks; block++) {
+                auto bytes_vec = _mm512_load_si512(bytes + block * BLOCK_SIZE);
+
+                for (ElementType bin = 0; bin < BINS_PER_PASS; bin++) {
+                    auto equal = _mm512_cmpeq_epi8_mask(bytes_vec, _mm512_set1_epi8(first_bin + bin));
+                    counters[bin] = _mm512_mask_sub_epi8(counters[bin], equal, counters[bin], minus_one);
+                }
+            }
+
+            // The sum of absolute differences to zero widens the byte counters into eight 64 bit sums
+            for (ElementType bin = 0; bin < BINS_PER_PASS && first_bin + bin < range; bin++) {
+                histogram[first_bin + bin] += _mm512_reduce_add_epi64(_mm512_sad_epu8(counters[bin], zero));
+            }
+        }
+    }
+
+    for (size_t i = blocks * BLOCK_SIZE; i < data.size(); i++) {
+        histogram[data[i]]++;
+    }
+
+    return histogram;
+}
+#endif
+
 template<ElementType range>
 std::array<ElementType, range> __attribute__ ((noinline)) histogramSequential(std::vector<ElementType> &data) {
     std::array<ElementType, range> histogram = {};
@@ -186,6 +335,26 @@ void testRange() {
     after = std::chrono::high_resolution_clock::now();
     printArray(result);
     std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+    auto unroll_durations = std::array<std::chrono::high_resolution_clock::duration, 3>{after - before};
+
+    std::cout << "Vector Instructions (shifted vector, 2 vectors per iteration):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = histogramUnrolledShiftedVector<histogram_range, 2>(data);
+    after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+    unroll_durations[1] = after - before;
+
+    std::cout << "Vector Instructions (shifted vector, 4 vectors per iteration):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = histogramUnrolledShiftedVector<histogram_range, 4>(data);
+    after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+    unroll_durations[2] = after - before;
+
+    auto fastest = std::min_element(unroll_durations.begin(), unroll_durations.end()) - unroll_durations.begin();
+    std::cout << "Fastest unroll factor: " << (1 << fastest) << std::endl;
 
 #ifdef __AVX512VPOPCNTDQ__
     std::cout << "Vector Instructions (popcnt intrinsic):" << std::endl;
@@ -196,6 +365,26 @@ void testRange() {
     std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
 #endif
 
+    if constexpr (histogram_range <= 16) {
+        std::cout << "Vector Instructions (compare and count):" << std::endl;
+        before = std::chrono::high_resolution_clock::now();
+        result = histogramCompareCount<histogram_range>(data);
+        after = std::chrono::high_resolution_clock::now();
+        printArray(result);
+        std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+    }
+
+    if constexpr (histogram_range <= 64) {
+#ifdef __AVX512BW__
+        std::cout << "Vector Instructions (compare and count bytes):" << std::endl;
+        before = std::chrono::high_resolution_clock::now();
+        result = histogramCompareCountBytes<histogram_range>(data);
+        after = std::chrono::high_resolution_clock::now();
+        printArray(result);
+        std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+#endif
+    }
+
     std::cout << "Sequential (again):" << std::endl;
     before = std::chrono::high_resolution_clock::now();
     result = histogramSequential<histogram_range>(data);
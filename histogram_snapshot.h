@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <immintrin.h>
+
+// Binary snapshot of a histogram with uint32 counts, meant to be shipped between nodes and merged.
+// A 16 byte header is followed by either
+//  - dense:  range counts as raw little endian uint32, or
+//  - sparse: one pair of LEB128 varints per non-empty bin, the distance to the previous non-empty bin and the count.
+// The encoder picks whichever of both is smaller.
+// Decoding the varints is inherently serial and stays scalar, turning the deltas into bins and adding the counts is vectorized.
+struct SnapshotHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t encoding;
+    uint8_t count_size;
+    uint8_t reserved;
+    uint32_t range;
+    uint32_t bins;
+};
+static_assert(sizeof(SnapshotHeader) == 16, "The header has to be packed");
+
+const char SNAPSHOT_MAGIC[4] = {'H', 'I', 'S', 'T'};
+const uint8_t SNAPSHOT_VERSION = 1;
+const uint8_t SNAPSHOT_DENSE = 0;
+const uint8_t SNAPSHOT_SPARSE = 1;
+// Even a sparse snapshot is decoded into all of its bins, so the range is capped at 1 GiB of counts
+const uint32_t SNAPSHOT_MAX_RANGE = 1 << 28;
+
+inline void writeVarint(std::vector<uint8_t> &output, uint32_t value) {
+    while (value >= 0x80) {
+        output.push_back(value | 0x80);
+        value >>= 7;
+    }
+    output.push_back(value);
+}
+
+inline uint32_t readVarint(const uint8_t *&position, const uint8_t *end) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (position == end) throw std::runtime_error("Snapshot is truncated");
+        uint8_t byte = *position++;
+        if (shift == 28 && byte > 0x0F) throw std::runtime_error("Snapshot contains a varint that is too large");
+        value |= uint32_t(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) return value;
+    }
+    throw std::runtime_error("Snapshot contains an invalid varint");
+}
+
+inline std::vector<uint8_t> encodeSnapshot(const uint32_t *histogram, uint32_t range) {
+    const size_t ELEMENT_COUNT = 16;
+
+    if (range > SNAPSHOT_MAX_RANGE) throw std::runtime_error("Histogram is too large for a snapshot");
+
+    // Collect the non-empty bins and their indices 16 bins at a time
+    std::vector<uint32_t> indices(range + ELEMENT_COUNT), counts(range + ELEMENT_COUNT);
+    size_t bins = 0;
+    auto lane_index = _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+
+    for (uint32_t bin = 0; bin < range; bin += ELEMENT_COUNT) {
+        __mmask16 valid = range - bin >= ELEMENT_COUNT ? 0xFFFF : (1 << (range - bin)) - 1;
+        auto histogram_vec = _mm512_maskz_loadu_epi32(valid, histogram + bin);
+        __mmask16 non_empty = _mm512_test_epi32_mask(histogram_vec, histogram_vec);
+        if (non_empty == 0) continue;
+
+        _mm512_mask_compressstoreu_epi32(counts.data() + bins, non_empty, histogram_vec);
+        _mm512_mask_compressstoreu_epi32(indices.data() + bins, non_empty, _mm512_add_epi32(_mm512_set1_epi32(bin), lane_index));
+        bins += __builtin_popcount(non_empty);
+    }
+
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.count_size = sizeof(uint32_t);
+    header.range = range;
+
+    std::vector<uint8_t> output(sizeof(header));
+    uint32_t previous = 0;
+    for (size_t i = 0; i < bins && output.size() < sizeof(header) + range * sizeof(uint32_t); i++) {
+        writeVarint(output, indices[i] - previous);
+        writeVarint(output, counts[i]);
+        previous = indices[i];
+    }
+
+    if (output.size() < sizeof(header) + range * sizeof(uint32_t)) {
+        header.encoding = SNAPSHOT_SPARSE;
+        header.bins = bins;
+    } else {
+        header.encoding = SNAPSHOT_DENSE;
+        header.bins = range;
+        output.resize(sizeof(header) + range * sizeof(uint32_t));
+        if (range != 0) std::memcpy(output.data() + sizeof(header), histogram, range * sizeof(uint32_t));
+    }
+
+    std::memcpy(output.data(), &header, sizeof(header));
+    return output;
+}
+
+inline SnapshotHeader readSnapshotHeader(const uint8_t *data, size_t size) {
+    SnapshotHeader header;
+    if (size < sizeof(header)) throw std::runtime_error("Snapshot is truncated");
+    std::memcpy(&header, data, sizeof(header));
+
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) throw std::runtime_error("Not a histogram snapshot");
+    if (header.version != SNAPSHOT_VERSION) throw std::runtime_error("Unsupported snapshot version");
+    if (header.count_size != sizeof(uint32_t)) throw std::runtime_error("Unsupported snapshot count size");
+    if (header.range > SNAPSHOT_MAX_RANGE) throw std::runtime_error("Snapshot range is too large");
+
+    const size_t payload_size = size - sizeof(header);
+    if (header.encoding == SNAPSHOT_DENSE) {
+        if (header.bins != header.range || payload_size != size_t(header.range) * sizeof(uint32_t))
+            throw std::runtime_error("Dense snapshot has the wrong size");
+    } else if (header.encoding == SNAPSHOT_SPARSE) {
+        // Every bin takes at least one byte for its delta and one for its count
+        if (header.bins > header.range || header.bins > payload_size / 2) throw std::runtime_error("Sparse snapshot has the wrong size");
+    } else {
+        throw std::runtime_error("Unknown snapshot encoding");
+    }
+
+    return header;
+}
+
+// Adds a snapshot straight into result, a sparse one without expanding it to all of its bins first.
+// An empty result takes the range of the snapshot. If the snapshot turns out to be malformed,
+// an exception is thrown and result may already contain part of it.
+inline void mergeSnapshot(const uint8_t *data, size_t size, std::vector<uint32_t> &result) {
+    const size_t ELEMENT_COUNT = 16;
+
+    SnapshotHeader header = readSnapshotHeader(data, size);
+    const uint8_t *position = data + sizeof(header);
+    const uint8_t *end = data + size;
+
+    if (result.empty()) result.resize(header.range);
+    if (result.size() != header.range) throw std::runtime_error("Histograms with different ranges cannot be merged");
+
+    if (header.encoding == SNAPSHOT_DENSE) {
+        for (uint32_t bin = 0; bin < header.range; bin += ELEMENT_COUNT) {
+            __mmask16 valid = header.range - bin >= ELEMENT_COUNT ? 0xFFFF : (1 << (header.range - bin)) - 1;
+            auto sum_vec = _mm512_maskz_loadu_epi32(valid, result.data() + bin);
+            sum_vec = _mm512_add_epi32(sum_vec, _mm512_maskz_loadu_epi32(valid, position + bin * sizeof(uint32_t)));
+            _mm512_mask_storeu_epi32(result.data() + bin, valid, sum_vec);
+        }
+        return;
+    }
+
+    // The pairs are decoded 16 at a time. Their bins are the prefix sums of the deltas and distinct,
+    // so the counts are added with a gather and a scatter without conflict detection.
+    alignas(64) uint32_t deltas[ELEMENT_COUNT], counts[ELEMENT_COUNT];
+    uint64_t last_bin = 0;
+    auto zero = _mm512_setzero_si512();
+    auto last_lane = _mm512_set1_epi32(ELEMENT_COUNT - 1);
+    auto carry = zero;
+
+    for (uint32_t i = 0; i < header.bins; i += ELEMENT_COUNT) {
+        uint32_t pairs = std::min<uint32_t>(header.bins - i, ELEMENT_COUNT);
+        for (uint32_t pair = 0; pair < pairs; pair++) {
+            deltas[pair] = readVarint(position, end);
+            counts[pair] = readVarint(position, end);
+
+            if (i + pair != 0 && deltas[pair] == 0) throw std::runtime_error("Snapshot bins are not in ascending order");
+            last_bin += deltas[pair];
+        }
+        // Also keeps the prefix sums below from wrapping around
+        if (last_bin >= header.range) throw std::runtime_error("Snapshot bin is out of range");
+
+        __mmask16 valid = (1 << pairs) - 1;
+        auto bins_vec = _mm512_maskz_load_epi32(valid, deltas);
+
+        bins_vec = _mm512_add_epi32(bins_vec, _mm512_alignr_epi32(bins_vec, zero, 15));
+        bins_vec = _mm512_add_epi32(bins_vec, _mm512_alignr_epi32(bins_vec, zero, 14));
+        bins_vec = _mm512_add_epi32(bins_vec, _mm512_alignr_epi32(bins_vec, zero, 12));
+        bins_vec = _mm512_add_epi32(bins_vec, _mm512_alignr_epi32(bins_vec, zero, 8));
+        bins_vec = _mm512_add_epi32(bins_vec, carry);
+
+        auto sum_vec = _mm512_mask_i32gather_epi32(zero, valid, bins_vec, result.data(), sizeof(uint32_t));
+        sum_vec = _mm512_add_epi32(sum_vec, _mm512_maskz_load_epi32(valid, counts));
+        _mm512_mask_i32scatter_epi32(result.data(), valid, bins_vec, sum_vec, sizeof(uint32_t));
+
+        carry = _mm512_permutexvar_epi32(last_lane, bins_vec);
+    }
+
+    if (position != end) throw std::runtime_error("Snapshot has trailing bytes");
+}
+
+inline std::vector<uint32_t> decodeSnapshot(const uint8_t *data, size_t size) {
+    SnapshotHeader header = readSnapshotHeader(data, size);
+    std::vector<uint32_t> histogram(header.range);
+
+    if (header.encoding == SNAPSHOT_DENSE) {
+        if (header.range != 0) std::memcpy(histogram.data(), data + sizeof(header), header.range * sizeof(uint32_t));
+    } else {
+        mergeSnapshot(data, size, histogram);
+    }
+
+    return histogram;
+}
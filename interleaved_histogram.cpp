@@ -0,0 +1,172 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <immintrin.h>
+#include <algorithm>
+
+const size_t VECTOR_SIZE = 512 / 8;
+using ElementType = uint32_t;
+const size_t ELEMENT_COUNT = VECTOR_SIZE / sizeof(ElementType);
+
+template<ElementType range, size_t channels>
+void printChannels(std::array<ElementType, channels * range> &histograms) {
+    for (size_t channel = 0; channel < channels; channel++) {
+        std::cout << channel << ": [";
+        for (size_t bin = 0; bin < range; bin++) {
+            std::cout << std::setw(8) << histograms[channel * range + bin];
+        }
+        std::cout << "]" << std::endl;
+    }
+}
+
+// Histograms of every channel of interleaved 8-bit pixels, e.g. RGB or RGBA, stored one after another in a single table.
+// A sample of channel c with value v is counted in bin c * range + v, so all channels share one conflict detection and scatter.
+// channels vectors cover exactly ELEMENT_COUNT pixels, which makes the channel of every lane the same in every iteration.
+template<ElementType range, size_t channels>
+std::array<ElementType, channels * range> __attribute__ ((noinline)) interleavedHistogramShiftedVector(std::vector<uint8_t> &data) {
+    std::array<ElementType, channels * range> histogram = {};
+
+    const size_t BLOCK_SIZE = channels * ELEMENT_COUNT;
+    auto inc_const = _mm512_set1_epi32(1);
+
+    __m512i channel_offsets[channels];
+    for (size_t v = 0; v < channels; v++) {
+        alignas(VECTOR_SIZE) ElementType offsets[ELEMENT_COUNT];
+        for (size_t lane = 0; lane < ELEMENT_COUNT; lane++) {
+            offsets[lane] = (v * ELEMENT_COUNT + lane) % channels * range;
+        }
+        channel_offsets[v] = _mm512_load_si512(offsets);
+    }
+
+    for (size_t i = 0; i + BLOCK_SIZE <= data.size(); i += BLOCK_SIZE) {
+        for (size_t v = 0; v < channels; v++) {
+            auto samples = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data.data() + i + v * ELEMENT_COUNT));
+            auto data_vec = _mm512_add_epi32(_mm512_cvtepu8_epi32(samples), channel_offsets[v]);
+
+            auto conflicts = _mm512_conflict_epi32(data_vec);
+            auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+            histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+            while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+                auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+                histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+                conflicts = _mm512_srli_epi32(conflicts, 1);
+            }
+
+            _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+        }
+    }
+
+    for (size_t i = data.size() / BLOCK_SIZE * BLOCK_SIZE; i < data.size(); i++) {
+        histogram[i % channels * range + data[i]]++;
+    }
+
+    return histogram;
+}
+
+// Copies every channel into its own buffer and histograms the channels one after another
+template<ElementType range, size_t channels>
+std::array<ElementType, channels * range> __attribute__ ((noinline)) deinterleavedHistogramShiftedVector(std::vector<uint8_t> &data) {
+    std::array<ElementType, channels * range> histogram = {};
+
+    auto inc_const = _mm512_set1_epi32(1);
+    std::vector<ElementType> channel_data(data.size() / channels);
+
+    for (size_t channel = 0; channel < channels; channel++) {
+        for (size_t pixel = 0; pixel < channel_data.size(); pixel++) {
+            channel_data[pixel] = data[pixel * channels + channel];
+        }
+
+        ElementType *channel_histogram = histogram.data() + channel * range;
+
+        for (size_t i = 0; i + ELEMENT_COUNT <= channel_data.size(); i += ELEMENT_COUNT) {
+            auto data_vec = _mm512_loadu_si512(channel_data.data() + i);
+            auto conflicts = _mm512_conflict_epi32(data_vec);
+            auto histogram_vec = _mm512_i32gather_epi32(data_vec, channel_histogram, sizeof(ElementType));
+            histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+            while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+                auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+                histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+                conflicts = _mm512_srli_epi32(conflicts, 1);
+            }
+
+            _mm512_i32scatter_epi32(channel_histogram, data_vec, histogram_vec, sizeof(ElementType));
+        }
+
+        for (size_t i = channel_data.size() & ~(ELEMENT_COUNT - 1); i < channel_data.size(); i++) {
+            channel_histogram[channel_data[i]]++;
+        }
+    }
+
+    return histogram;
+}
+
+template<ElementType range, size_t channels>
+std::array<ElementType, channels * range> __attribute__ ((noinline)) interleavedHistogramSequential(std::vector<uint8_t> &data) {
+    std::array<ElementType, channels * range> histogram = {};
+
+    for (size_t i = 0; i < data.size(); i++) {
+        histogram[i % channels * range + data[i]]++;
+    }
+
+    return histogram;
+}
+
+template<ElementType histogram_range, size_t channels>
+void testRange() {
+    const size_t pixels = 10'000'000 / channels;
+    std::cout << "Histogram of " << channels << " interleaved channels between 0 and " << histogram_range << " (exclusive):" << std::endl;
+
+    std::random_device seed;
+    std::default_random_engine rnd(seed());
+    std::uniform_int_distribution<uint32_t> dist(0, histogram_range - 1);
+    std::vector<uint8_t> data(pixels * channels);
+
+    for (uint8_t &i : data)
+        i = dist(rnd);
+
+    std::cout << "Sequential:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto result = interleavedHistogramSequential<histogram_range, channels>(data);
+    auto after = std::chrono::high_resolution_clock::now();
+    printChannels<histogram_range, channels>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (deinterleaved, one pass per channel):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = deinterleavedHistogramShiftedVector<histogram_range, channels>(data);
+    after = std::chrono::high_resolution_clock::now();
+    printChannels<histogram_range, channels>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (interleaved, single pass):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = interleavedHistogramShiftedVector<histogram_range, channels>(data);
+    after = std::chrono::high_resolution_clock::now();
+    printChannels<histogram_range, channels>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Sequential (again):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = interleavedHistogramSequential<histogram_range, channels>(data);
+    after = std::chrono::high_resolution_clock::now();
+    printChannels<histogram_range, channels>(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+}
+
+int main() {
+    testRange<32, 3>();
+    std::cout << "\n----------------------------------------\n";
+    testRange<256, 3>();
+    std::cout << "\n----------------------------------------\n";
+    testRange<256, 4>();
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <ctime>
+#include <random>
+#include <chrono>
+#include <iomanip>
+#include <immintrin.h>
+#include <algorithm>
+
+const size_t VECTOR_SIZE = 512 / 8;
+using ElementType = int32_t;
+const size_t ELEMENT_COUNT = VECTOR_SIZE / sizeof(ElementType);
+
+template<typename type, size_t length>
+void printArray(std::array<type, length> &array) {
+    std::cout << "[";
+    for (const auto &element: array) {
+        std::cout << std::setw(8) << element;
+    }
+    std::cout << "]" << std::endl;
+}
+
+// Smallest value whose cumulative count exceeds rank, i.e. the value at position rank of the sorted window.
+// rank has to be smaller than the number of values in the histogram.
+template<ElementType range>
+ElementType rankQuery(const ElementType *histogram, ElementType rank) {
+    ElementType value = 0;
+    for (ElementType count = histogram[0]; count <= rank; count += histogram[++value]);
+    return value;
+}
+
+// Same as rankQuery, but 16 bins at a time. The cumulative counts of a vector are built in registers,
+// the first bin exceeding rank is found with a compare and a count of the trailing zeros of the mask.
+template<ElementType range>
+ElementType rankQueryVector(const ElementType *histogram, ElementType rank) {
+    auto zero = _mm512_setzero_si512();
+    auto last_lane = _mm512_set1_epi32(ELEMENT_COUNT - 1);
+    auto rank_vec = _mm512_set1_epi32(rank);
+    auto carry = zero;
+
+    for (size_t bin = 0; bin < range; bin += ELEMENT_COUNT) {
+        auto count_vec = _mm512_load_si512(histogram + bin);
+        count_vec = _mm512_add_epi32(count_vec, _mm512_alignr_epi32(count_vec, zero, 15));
+        count_vec = _mm512_add_epi32(count_vec, _mm512_alignr_epi32(count_vec, zero, 14));
+        count_vec = _mm512_add_epi32(count_vec, _mm512_alignr_epi32(count_vec, zero, 12));
+        count_vec = _mm512_add_epi32(count_vec, _mm512_alignr_epi32(count_vec, zero, 8));
+        count_vec = _mm512_add_epi32(count_vec, carry);
+
+        __mmask16 exceeds = _mm512_cmpgt_epi32_mask(count_vec, rank_vec);
+        if (exceeds != 0) return bin + __builtin_ctz(exceeds);
+        carry = _mm512_permutexvar_epi32(last_lane, count_vec);
+    }
+
+    return range - 1;
+}
+
+// Filter over a (2 * radius + 1)² window in the style of Perreault and Hébert, query maps the histogram of a window to the result.
+// Every column keeps a histogram of its 2 * radius + 1 pixels, which only has to be updated by one pixel when moving down a row.
+// Moving the window one column to the right adds the entering and subtracts the leaving column histogram with vector instructions.
+// Only pixels whose window lies completely inside the image are filtered, the border is left at zero.
+template<ElementType range, typename Query>
+std::vector<ElementType> slidingWindowFilter(std::vector<ElementType> &data, size_t rows, size_t cols, size_t radius, Query query) {
+    static_assert(range % ELEMENT_COUNT == 0, "The bins have to fill whole vectors");
+
+    std::vector<ElementType> result(data.size());
+    const size_t window = 2 * radius + 1;
+
+    if (data.size() != rows * cols || rows < window || cols < window) return result;
+
+    std::vector<ElementType> column_histograms(cols * range);
+    alignas(VECTOR_SIZE) std::array<ElementType, range> histogram;
+
+    for (size_t current_row = 0; current_row < window; current_row++) {
+        for (size_t current_col = 0; current_col < cols; current_col++) {
+            column_histograms[current_col * range + data[current_row * cols + current_col]]++;
+        }
+    }
+
+    for (size_t current_row = radius; current_row < rows - radius; current_row++) {
+        if (current_row != radius) {
+            for (size_t current_col = 0; current_col < cols; current_col++) {
+                column_histograms[current_col * range + data[(current_row - radius - 1) * cols + current_col]]--;
+                column_histograms[current_col * range + data[(current_row + radius) * cols + current_col]]++;
+            }
+        }
+
+        for (size_t bin = 0; bin < range; bin += ELEMENT_COUNT) {
+            auto histogram_vec = _mm512_setzero_si512();
+            for (size_t current_col = 0; current_col < window; current_col++) {
+                histogram_vec = _mm512_add_epi32(histogram_vec, _mm512_loadu_si512(&column_histograms[current_col * range + bin]));
+            }
+            _mm512_store_si512(&histogram[bin], histogram_vec);
+        }
+        result[current_row * cols + radius] = query(histogram.data());
+
+        for (size_t current_col = radius + 1; current_col < cols - radius; current_col++) {
+            const ElementType *entering = &column_histograms[(current_col + radius) * range];
+            const ElementType *leaving = &column_histograms[(current_col - radius - 1) * range];
+
+            for (size_t bin = 0; bin < range; bin += ELEMENT_COUNT) {
+                auto histogram_vec = _mm512_load_si512(&histogram[bin]);
+                histogram_vec = _mm512_add_epi32(histogram_vec, _mm512_loadu_si512(entering + bin));
+                histogram_vec = _mm512_sub_epi32(histogram_vec, _mm512_loadu_si512(leaving + bin));
+                _mm512_store_si512(&histogram[bin], histogram_vec);
+            }
+
+            result[current_row * cols + current_col] = query(histogram.data());
+        }
+    }
+
+    return result;
+}
+
+template<ElementType range>
+std::vector<ElementType> __attribute__ ((noinline)) rankFilterSlidingWindow(std::vector<ElementType> &data, size_t rows, size_t cols, size_t radius, ElementType rank) {
+    const size_t window = 2 * radius + 1;
+    rank = std::clamp<ElementType>(rank, 0, window * window - 1);
+
+    return slidingWindowFilter<range>(data, rows, cols, radius, [rank](const ElementType *histogram) {
+        return rankQueryVector<range>(histogram, rank);
+    });
+}
+
+// Local contrast, the difference between the largest and the smallest value of the window, i.e. of its last and its first rank
+template<ElementType range>
+std::vector<ElementType> __attribute__ ((noinline)) contrastFilterSlidingWindow(std::vector<ElementType> &data, size_t rows, size_t cols, size_t radius) {
+    const size_t window = 2 * radius + 1;
+    const ElementType last_rank = window * window - 1;
+
+    return slidingWindowFilter<range>(data, rows, cols, radius, [last_rank](const ElementType *histogram) {
+        return rankQueryVector<range>(histogram, last_rank) - rankQueryVector<range>(histogram, 0);
+    });
+}
+
+template<ElementType range>
+std::vector<ElementType> __attribute__ ((noinline)) rankFilterSequential(std::vector<ElementType> &data, size_t rows, size_t cols, size_t radius, ElementType rank) {
+    std::vector<ElementType> result(data.size());
+    const size_t window = 2 * radius + 1;
+
+    if (data.size() != rows * cols || rows < window || cols < window) return result;
+    rank = std::clamp<ElementType>(rank, 0, window * window - 1);
+
+    for (size_t current_row = radius; current_row < rows - radius; current_row++) {
+        for (size_t current_col = radius; current_col < cols - radius; current_col++) {
+            std::array<ElementType, range> histogram = {};
+
+            for (size_t window_row = current_row - radius; window_row <= current_row + radius; window_row++) {
+                for (size_t window_col = current_col - radius; window_col <= current_col + radius; window_col++) {
+                    histogram[data[window_row * cols + window_col]]++;
+                }
+            }
+
+            result[current_row * cols + current_col] = rankQuery<range>(histogram.data(), rank);
+        }
+    }
+
+    return result;
+}
+
+template<ElementType range>
+std::vector<ElementType> __attribute__ ((noinline)) contrastFilterSequential(std::vector<ElementType> &data, size_t rows, size_t cols, size_t radius) {
+    std::vector<ElementType> result(data.size());
+    const size_t window = 2 * radius + 1;
+
+    if (data.size() != rows * cols || rows < window || cols < window) return result;
+
+    for (size_t current_row = radius; current_row < rows - radius; current_row++) {
+        for (size_t current_col = radius; current_col < cols - radius; current_col++) {
+            ElementType minimum = range - 1, maximum = 0;
+
+            for (size_t window_row = current_row - radius; window_row <= current_row + radius; window_row++) {
+                for (size_t window_col = current_col - radius; window_col <= current_col + radius; window_col++) {
+                    minimum = std::min(minimum, data[window_row * cols + window_col]);
+                    maximum = std::max(maximum, data[window_row * cols + window_col]);
+                }
+            }
+
+            result[current_row * cols + current_col] = maximum - minimum;
+        }
+    }
+
+    return result;
+}
+
+template<ElementType range>
+std::array<ElementType, range> histogramOf(std::vector<ElementType> &data) {
+    std::array<ElementType, range> histogram = {};
+
+    for (const auto &datum: data) {
+        histogram[datum]++;
+    }
+
+    return histogram;
+}
+
+template<ElementType histogram_range>
+void testRange(size_t radius, double percentile) {
+    const size_t rows = 1000, cols = 1000;
+    const size_t window = 2 * radius + 1;
+    const ElementType rank = (ElementType) (percentile * (window * window - 1));
+    std::cout << "Histogram between 0 and " << histogram_range << " (exclusive) of the " << percentile * 100 << "th percentile in a "
+              << window << "x" << window << " window:" << std::endl;
+
+    std::random_device seed;
+    std::default_random_engine rnd(seed());
+    std::uniform_int_distribution<ElementType> dist(0, histogram_range - 1);
+    std::vector<ElementType> data(rows * cols);
+
+    for (ElementType &i: data)
+        i = dist(rnd);
+
+    std::cout << "Sequential:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto reference = rankFilterSequential<histogram_range>(data, rows, cols, radius, rank);
+    auto after = std::chrono::high_resolution_clock::now();
+    auto result = histogramOf<histogram_range>(reference);
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (sliding window):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    auto filtered = rankFilterSlidingWindow<histogram_range>(data, rows, cols, radius, rank);
+    after = std::chrono::high_resolution_clock::now();
+    result = histogramOf<histogram_range>(filtered);
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+    std::cout << "Both filtered images are " << (filtered == reference ? "equal" : "DIFFERENT") << std::endl;
+
+    std::cout << "Sequential (again):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    filtered = rankFilterSequential<histogram_range>(data, rows, cols, radius, rank);
+    after = std::chrono::high_resolution_clock::now();
+    result = histogramOf<histogram_range>(filtered);
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Local contrast, sequential:" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    reference = contrastFilterSequential<histogram_range>(data, rows, cols, radius);
+    after = std::chrono::high_resolution_clock::now();
+    result = histogramOf<histogram_range>(reference);
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Local contrast, vector instructions (sliding window):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    filtered = contrastFilterSlidingWindow<histogram_range>(data, rows, cols, radius);
+    after = std::chrono::high_resolution_clock::now();
+    result = histogramOf<histogram_range>(filtered);
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+    std::cout << "Both contrast images are " << (filtered == reference ? "equal" : "DIFFERENT") << std::endl;
+
+}
+
+int main() {
+    testRange<16>(1, 0.5);
+    std::cout << "\n----------------------------------------\n";
+    testRange<32>(3, 0.5);
+    std::cout << "\n----------------------------------------\n";
+    testRange<256>(7, 0.9);
+
+    return 0;
+}
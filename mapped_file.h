@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cctype>
+#include <algorithm>
+#include <string>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Files up to this size are faulted in completely when they are mapped.
+// Larger files are only read ahead sequentially so the resident memory stays bounded by the caller releasing
+// the parts it is done with.
+const size_t POPULATE_LIMIT = 64 * 1024 * 1024;
+
+class MappedFile {
+public:
+    explicit MappedFile(const char *path) {
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error(std::string("Could not open ") + path);
+
+        struct stat info = {};
+        if (fstat(fd, &info) != 0) {
+            close(fd);
+            throw std::runtime_error(std::string("Could not stat ") + path);
+        }
+        length = info.st_size;
+
+        if (length != 0) {
+            int flags = MAP_PRIVATE | (length <= POPULATE_LIMIT ? MAP_POPULATE : 0);
+            void *mapping = mmap(nullptr, length, PROT_READ, flags, fd, 0);
+            if (mapping == MAP_FAILED) {
+                close(fd);
+                throw std::runtime_error(std::string("Could not map ") + path);
+            }
+            bytes = static_cast<const uint8_t *>(mapping);
+            madvise(mapping, length, MADV_SEQUENTIAL);
+        }
+
+        close(fd);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile() {
+        if (bytes != nullptr) munmap(const_cast<uint8_t *>(bytes), length);
+    }
+
+    const uint8_t *data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+    // Drops the pages that lie completely before `end` from the page tables.
+    // They are clean file pages, so touching them again simply reads them back from the page cache.
+    void release(size_t end) const {
+        size_t page_size = sysconf(_SC_PAGESIZE);
+        end = std::min(end, length) & ~(page_size - 1);
+        if (end != 0) madvise(const_cast<uint8_t *>(bytes), end, MADV_DONTNEED);
+    }
+
+private:
+    const uint8_t *bytes = nullptr;
+    size_t length = 0;
+};
+
+// View of the raster of a binary PGM (P5) or PAM (P7) image inside a mapped file.
+struct Image {
+    const uint8_t *pixels;
+    size_t rows;
+    size_t cols;
+    size_t channels;
+    uint32_t max_value;
+};
+
+inline size_t skipNetpbmWhitespace(const MappedFile &file, size_t position) {
+    const uint8_t *bytes = file.data();
+    while (position < file.size()) {
+        if (bytes[position] == '#') {
+            while (position < file.size() && bytes[position] != '\n') position++;
+        } else if (std::isspace(bytes[position])) {
+            position++;
+        } else {
+            break;
+        }
+    }
+    return position;
+}
+
+inline std::string readNetpbmToken(const MappedFile &file, size_t &position) {
+    position = skipNetpbmWhitespace(file, position);
+    size_t begin = position;
+    while (position < file.size() && !std::isspace(file.data()[position])) position++;
+    return std::string(reinterpret_cast<const char *>(file.data()) + begin, position - begin);
+}
+
+// Header values have to be positive decimal numbers, std::stoul would also accept signs and wrap negative values around
+inline size_t parseNetpbmNumber(const std::string &token) {
+    if (token.empty()) throw std::runtime_error("Image header is truncated");
+
+    size_t value = 0;
+    for (char digit : token) {
+        if (digit < '0' || digit > '9') throw std::runtime_error("Image header contains an invalid number: " + token);
+        if (__builtin_mul_overflow(value, 10, &value) || __builtin_add_overflow(value, digit - '0', &value))
+            throw std::runtime_error("Image header contains a number that is too large: " + token);
+    }
+    if (value == 0) throw std::runtime_error("Image header contains a zero size");
+
+    return value;
+}
+
+inline Image parseNetpbm(const MappedFile &file) {
+    Image image = {nullptr, 0, 0, 1, 0};
+    size_t position = 0;
+
+    std::string magic = readNetpbmToken(file, position);
+    if (magic == "P5") {
+        image.cols = parseNetpbmNumber(readNetpbmToken(file, position));
+        image.rows = parseNetpbmNumber(readNetpbmToken(file, position));
+        image.max_value = std::min<size_t>(parseNetpbmNumber(readNetpbmToken(file, position)), UINT32_MAX);
+        // Exactly one whitespace character separates the header from the raster
+        position++;
+    } else if (magic == "P7") {
+        for (std::string token = readNetpbmToken(file, position); token != "ENDHDR"; token = readNetpbmToken(file, position)) {
+            if (token.empty()) throw std::runtime_error("PAM header is missing ENDHDR");
+
+            if (token == "WIDTH") image.cols = parseNetpbmNumber(readNetpbmToken(file, position));
+            else if (token == "HEIGHT") image.rows = parseNetpbmNumber(readNetpbmToken(file, position));
+            else if (token == "DEPTH") image.channels = parseNetpbmNumber(readNetpbmToken(file, position));
+            else if (token == "MAXVAL") image.max_value = std::min<size_t>(parseNetpbmNumber(readNetpbmToken(file, position)), UINT32_MAX);
+            else if (token == "TUPLTYPE") readNetpbmToken(file, position);
+        }
+        position++;
+    } else {
+        throw std::runtime_error("Only binary PGM (P5) and PAM (P7) images are supported");
+    }
+
+    if (image.rows == 0 || image.cols == 0) throw std::runtime_error("Image header is missing the size");
+    if (image.max_value == 0 || image.max_value > UINT8_MAX)
+        throw std::runtime_error("Only images with 8-bit samples are supported");
+
+    size_t raster_size;
+    if (__builtin_mul_overflow(image.rows, image.cols, &raster_size) || __builtin_mul_overflow(raster_size, image.channels, &raster_size)
+        || position > file.size() || raster_size > file.size() - position)
+        throw std::runtime_error("Image raster is truncated");
+
+    image.pixels = file.data() + position;
+    return image;
+}
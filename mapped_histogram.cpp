@@ -0,0 +1,239 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <iomanip>
+#include <immintrin.h>
+#include <algorithm>
+#include "mapped_file.h"
+
+const size_t VECTOR_SIZE = 512 / 8;
+using ElementType = int32_t;
+const size_t ELEMENT_COUNT = VECTOR_SIZE / sizeof(ElementType);
+
+// Amount of input that is processed before the pages behind it are released again
+const size_t BAND_ELEMENTS = 1 << 20;
+const size_t BAND_ROWS = 256;
+
+__m512i clamp(__m512i value, ElementType low, ElementType high) {
+    __m512i high_vec = _mm512_set1_epi32(high);
+    value = _mm512_min_epi32(high_vec, value);
+
+    __m512i low_vec = _mm512_set1_epi32(low);
+    value = _mm512_max_epi32(low_vec, value);
+
+    return value;
+}
+
+template<typename type, size_t length>
+void printArray(std::array<type, length> &array) {
+    std::cout << "[";
+    for (const auto &element : array) {
+        std::cout << std::setw(8) << element;
+    }
+    std::cout << "]" << std::endl;
+}
+
+// Raw column of native endian uint32 values. Values outside of the range are counted in the last bin.
+template<ElementType range>
+void __attribute__ ((noinline)) columnHistogramShiftedVector(const uint32_t *data, size_t size, std::array<ElementType, range> &histogram) {
+    auto inc_const = _mm512_set1_epi32(1);
+    auto max_const = _mm512_set1_epi32(range - 1);
+
+    for (size_t i = 0; i + ELEMENT_COUNT <= size; i += ELEMENT_COUNT) {
+        auto data_vec = _mm512_min_epu32(_mm512_loadu_si512(data + i), max_const);
+        auto conflicts = _mm512_conflict_epi32(data_vec);
+        auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+        histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+        while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+            auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+            histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+            conflicts = _mm512_srli_epi32(conflicts, 1);
+        }
+
+        _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+    }
+
+    for (size_t i = size & ~(ELEMENT_COUNT - 1); i < size; i++) {
+        histogram[std::min<uint32_t>(data[i], range - 1)]++;
+    }
+}
+
+template<ElementType range>
+void __attribute__ ((noinline)) columnHistogramSequential(const uint32_t *data, size_t size, std::array<ElementType, range> &histogram) {
+    for (size_t i = 0; i < size; i++) {
+        histogram[std::min<uint32_t>(data[i], range - 1)]++;
+    }
+}
+
+// Same filter as convolutional_histogram.cpp, but the 8-bit pixels are widened straight out of the mapping.
+// Only the rows [row_begin, row_end) are filtered, which lets the caller walk the image in bands.
+template<ElementType range>
+void __attribute__ ((noinline)) convolutionalHistogramShiftedVector(const uint8_t *data, size_t cols, size_t row_begin, size_t row_end, std::array<ElementType, range> &histogram) {
+    auto inc_const = _mm512_set1_epi32(1);
+    auto conv_multiplier = _mm512_set1_epi32(9);
+
+    auto load = [&](size_t row, size_t col) {
+        return _mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(&data[row * cols + col])));
+    };
+
+    for (size_t current_row = row_begin; current_row < row_end; current_row++) {
+        size_t current_col = 1;
+        for (; current_col + ELEMENT_COUNT <= cols - 1; current_col += ELEMENT_COUNT) {
+            auto data_vec = _mm512_mullo_epi32(load(current_row, current_col), conv_multiplier);
+
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row + 1, current_col + 1));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row + 1, current_col));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row + 1, current_col - 1));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row, current_col + 1));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row, current_col - 1));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row - 1, current_col + 1));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row - 1, current_col));
+            data_vec = _mm512_sub_epi32(data_vec, load(current_row - 1, current_col - 1));
+            data_vec = clamp(data_vec, 0, range - 1);
+
+            auto conflicts = _mm512_conflict_epi32(data_vec);
+            auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+            histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+            while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+                auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+                histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+                conflicts = _mm512_srli_epi32(conflicts, 1);
+            }
+
+            _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+        }
+
+        for (; current_col < cols - 1; current_col++) {
+            ElementType value = 9 * data[current_row * cols + current_col]
+                                - data[(current_row + 1) * cols + (current_col + 1)]
+                                - data[(current_row + 1) * cols + current_col]
+                                - data[(current_row + 1) * cols + (current_col - 1)]
+                                - data[current_row * cols + (current_col + 1)]
+                                - data[current_row * cols + (current_col - 1)]
+                                - data[(current_row - 1) * cols + (current_col + 1)]
+                                - data[(current_row - 1) * cols + current_col]
+                                - data[(current_row - 1) * cols + (current_col - 1)];
+
+            histogram[std::clamp(value, 0, range - 1)]++;
+        }
+    }
+}
+
+template<ElementType range>
+void __attribute__ ((noinline)) convolutionalHistogramSequential(const uint8_t *data, size_t cols, size_t row_begin, size_t row_end, std::array<ElementType, range> &histogram) {
+    for (size_t current_row = row_begin; current_row < row_end; current_row++) {
+        for (size_t current_col = 1; current_col < cols - 1; current_col++) {
+            ElementType value = 9 * data[current_row * cols + current_col]
+                                - data[(current_row + 1) * cols + (current_col + 1)]
+                                - data[(current_row + 1) * cols + current_col]
+                                - data[(current_row + 1) * cols + (current_col - 1)]
+                                - data[current_row * cols + (current_col + 1)]
+                                - data[current_row * cols + (current_col - 1)]
+                                - data[(current_row - 1) * cols + (current_col + 1)]
+                                - data[(current_row - 1) * cols + current_col]
+                                - data[(current_row - 1) * cols + (current_col - 1)];
+
+            histogram[std::clamp(value, 0, range - 1)]++;
+        }
+    }
+}
+
+template<ElementType range, typename Kernel>
+std::array<ElementType, range> histogramColumnBands(const MappedFile &file, Kernel kernel) {
+    std::array<ElementType, range> histogram = {};
+
+    auto data = reinterpret_cast<const uint32_t *>(file.data());
+    size_t size = file.size() / sizeof(uint32_t);
+
+    for (size_t band = 0; band < size; band += BAND_ELEMENTS) {
+        kernel(data + band, std::min(BAND_ELEMENTS, size - band), histogram);
+        file.release((band + BAND_ELEMENTS) * sizeof(uint32_t));
+    }
+
+    return histogram;
+}
+
+template<ElementType range, typename Kernel>
+std::array<ElementType, range> histogramImageBands(const MappedFile &file, const Image &image, Kernel kernel) {
+    std::array<ElementType, range> histogram = {};
+
+    if (image.rows < 3 || image.cols < 3) return histogram;
+
+    for (size_t band = 1; band < image.rows - 1; band += BAND_ROWS) {
+        size_t band_end = std::min(band + BAND_ROWS, image.rows - 1);
+        kernel(image.pixels, image.cols, band, band_end, histogram);
+        // The last row of this band is still needed as the upper neighbour of the next one
+        file.release(image.pixels - file.data() + (band_end - 1) * image.cols);
+    }
+
+    return histogram;
+}
+
+template<ElementType histogram_range>
+void testColumn(const char *path) {
+    MappedFile file(path);
+    std::cout << "Histogram of " << file.size() / sizeof(uint32_t) << " values between 0 and " << histogram_range << " (exclusive):" << std::endl;
+
+    std::cout << "Sequential:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto result = histogramColumnBands<histogram_range>(file, columnHistogramSequential<histogram_range>);
+    auto after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (shifted vector):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = histogramColumnBands<histogram_range>(file, columnHistogramShiftedVector<histogram_range>);
+    after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+}
+
+template<ElementType histogram_range>
+void testImage(const char *path) {
+    MappedFile file(path);
+    Image image = parseNetpbm(file);
+    if (image.channels != 1) throw std::runtime_error("Only single channel images are supported");
+
+    std::cout << "Convolutional histogram of a " << image.cols << "x" << image.rows << " image between 0 and " << histogram_range << " (exclusive):" << std::endl;
+
+    std::cout << "Sequential:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto result = histogramImageBands<histogram_range>(file, image, convolutionalHistogramSequential<histogram_range>);
+    auto after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    std::cout << "Vector Instructions (shifted vector):" << std::endl;
+    before = std::chrono::high_resolution_clock::now();
+    result = histogramImageBands<histogram_range>(file, image, convolutionalHistogramShiftedVector<histogram_range>);
+    after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 3 || (std::strcmp(argv[1], "column") != 0 && std::strcmp(argv[1], "image") != 0)) {
+        std::cerr << "Usage: " << argv[0] << " column <file with raw uint32 values>" << std::endl;
+        std::cerr << "       " << argv[0] << " image <8-bit PGM or PAM file>" << std::endl;
+        return 1;
+    }
+
+    try {
+        if (std::strcmp(argv[1], "column") == 0) {
+            testColumn<256>(argv[2]);
+        } else {
+            testImage<256>(argv[2]);
+        }
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
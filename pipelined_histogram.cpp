@@ -0,0 +1,135 @@
+#include <iostream>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <chrono>
+#include <iomanip>
+#include <immintrin.h>
+#include <algorithm>
+#include "block_pipeline.h"
+
+const size_t VECTOR_SIZE = 512 / 8;
+using ElementType = int32_t;
+const size_t ELEMENT_COUNT = VECTOR_SIZE / sizeof(ElementType);
+
+template<typename type, size_t length>
+void printArray(std::array<type, length> &array) {
+    std::cout << "[";
+    for (const auto &element : array) {
+        std::cout << std::setw(8) << element;
+    }
+    std::cout << "]" << std::endl;
+}
+
+// Raw column of native endian uint32 values. Values outside of the range are counted in the last bin.
+template<ElementType range>
+void __attribute__ ((noinline)) columnHistogramShiftedVector(const uint32_t *data, size_t size, std::array<ElementType, range> &histogram) {
+    auto inc_const = _mm512_set1_epi32(1);
+    auto max_const = _mm512_set1_epi32(range - 1);
+
+    for (size_t i = 0; i + ELEMENT_COUNT <= size; i += ELEMENT_COUNT) {
+        auto data_vec = _mm512_min_epu32(_mm512_loadu_si512(data + i), max_const);
+        auto conflicts = _mm512_conflict_epi32(data_vec);
+        auto histogram_vec = _mm512_i32gather_epi32(data_vec, histogram.data(), sizeof(ElementType));
+        histogram_vec = _mm512_add_epi32(histogram_vec, inc_const);
+
+        while (_mm512_test_epi32_mask(conflicts, conflicts) != 0) {
+            auto conflicts_bit1 = _mm512_and_si512(conflicts, inc_const);
+            histogram_vec = _mm512_add_epi32(histogram_vec, conflicts_bit1);
+            conflicts = _mm512_srli_epi32(conflicts, 1);
+        }
+
+        _mm512_i32scatter_epi32(histogram.data(), data_vec, histogram_vec, sizeof(ElementType));
+    }
+
+    for (size_t i = size & ~(ELEMENT_COUNT - 1); i < size; i++) {
+        histogram[std::min<uint32_t>(data[i], range - 1)]++;
+    }
+}
+
+// Reads a block, then histograms it, so the disk and the kernel take turns
+template<ElementType range>
+std::array<ElementType, range> __attribute__ ((noinline)) histogramSerial(const char *path) {
+    std::array<ElementType, range> histogram = {};
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) throw std::runtime_error(std::string("Could not open ") + path);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    auto buffer = static_cast<uint8_t *>(std::aligned_alloc(BLOCK_ALIGNMENT, READ_BLOCK_SIZE));
+    if (buffer == nullptr) {
+        close(fd);
+        throw std::runtime_error("Could not allocate the read buffer");
+    }
+    size_t filled = 0;
+
+    for (ssize_t result; (result = read(fd, buffer + filled, READ_BLOCK_SIZE - filled)) != 0;) {
+        if (result < 0 && errno == EINTR) continue;
+        if (result < 0) {
+            std::free(buffer);
+            close(fd);
+            throw std::runtime_error(std::string("Could not read ") + path);
+        }
+
+        filled += result;
+        if (filled == READ_BLOCK_SIZE) {
+            columnHistogramShiftedVector<range>(reinterpret_cast<const uint32_t *>(buffer), filled / sizeof(uint32_t), histogram);
+            filled = 0;
+        }
+    }
+    columnHistogramShiftedVector<range>(reinterpret_cast<const uint32_t *>(buffer), filled / sizeof(uint32_t), histogram);
+
+    std::free(buffer);
+    close(fd);
+
+    return histogram;
+}
+
+// Histograms a block while the reader thread already fills the next ones
+template<ElementType range>
+std::array<ElementType, range> __attribute__ ((noinline)) histogramPipelined(BlockPipeline &pipeline) {
+    std::array<ElementType, range> histogram = {};
+
+    for (Block block; pipeline.next(block);) {
+        columnHistogramShiftedVector<range>(reinterpret_cast<const uint32_t *>(block.data), block.size / sizeof(uint32_t), histogram);
+        pipeline.recycle(block);
+    }
+
+    return histogram;
+}
+
+template<ElementType histogram_range>
+void testFile(const char *path) {
+    std::cout << "Histogram between 0 and " << histogram_range << " (exclusive):" << std::endl;
+
+    std::cout << "Serial read and compute:" << std::endl;
+    auto before = std::chrono::high_resolution_clock::now();
+    auto result = histogramSerial<histogram_range>(path);
+    auto after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+
+    before = std::chrono::high_resolution_clock::now();
+    BlockPipeline pipeline(path);
+    std::cout << "Pipelined read and compute (" << (pipeline.usesIoUring() ? "io_uring" : "pread thread") << "):" << std::endl;
+    result = histogramPipelined<histogram_range>(pipeline);
+    after = std::chrono::high_resolution_clock::now();
+    printArray(result);
+    std::cout << "The calculation took " << std::chrono::duration_cast<std::chrono::microseconds>(after - before).count() << "µs" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <file with raw uint32 values>" << std::endl;
+        return 1;
+    }
+
+    try {
+        testFile<256>(argv[1]);
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}